@@ -18,12 +18,15 @@ public:
     void moveDown(float offset);
     void rotate(float xoffset, float yoffset);
     void zoom(float yoffset);
+    void setPose(glm::vec3 pos, float new_yaw, float new_pitch, float new_fov); // ignores enable/disable
 
     void enable();
     void disable();
 
     glm::mat4 getViewMatrix();
     float getFOV();
+    float getYaw();
+    float getPitch();
 
     glm::vec3 getCoords();
 
@@ -0,0 +1,46 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+class Camera;
+
+struct CameraKeyframe {
+    float time; // seconds since the start of the path
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+    float fov;
+};
+
+// Camera keyframes recorded from live input (or generated) and replayed
+// independently of the frame rate: apply() interpolates the pose at any time,
+// so driving it with a fixed timestep gives the same camera every run.
+//
+// File format, one keyframe per line, '#' starts a comment:
+//     time x y z yaw pitch fov
+class CameraPath
+{
+public:
+    CameraPath();
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    void record(float time, Camera& camera);
+    void apply(float time, Camera& camera) const; // clamps to the first/last keyframe
+
+    float duration() const;
+    bool empty() const;
+
+    // full turn around center at the given distance and height
+    static CameraPath orbit(glm::vec3 center, float distance, float height, float duration);
+
+private:
+    std::vector<CameraKeyframe> keyframes;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+class Camera;
+
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction; // must be normalized
+};
+
+struct RayHit {
+    bool hit = false;
+    float distance = INFINITY;
+    glm::vec3 normal = glm::vec3(0.0f);
+    int instance = -1; // index of the instance given to setInstances
+};
+
+// CPU ray queries against instance bounding spheres (xyz = center, w = radius).
+// The spheres are stored in a BVH which is refitted when instances move and
+// rebuilt when the refitted tree gets too loose. Rays are traversed 4 at a time
+// with SSE when available.
+class SphereQuery
+{
+public:
+    SphereQuery();
+
+    void setInstances(const std::vector<glm::vec4>& spheres); // copy and build
+    void setInstance(size_t index, glm::vec3 center, float radius);
+    bool update(); // refit (or rebuild) after setInstance calls, true if rebuilt
+    void rebuild();
+
+    RayHit intersect(const Ray& ray) const;
+    void intersectPacket(const Ray* rays, RayHit* hits) const; // 4 rays
+    void intersect(const std::vector<Ray>& rays, std::vector<RayHit>& hits) const;
+
+    // reference implementation, tests every instance
+    RayHit intersectBruteForce(const Ray& ray) const;
+
+    // x, y in window coordinates (origin top left), same projection as the renderer
+    static Ray rayFromScreen(Camera& camera, float x, float y, float width, float height);
+    // one ray per pixel center, row by row
+    static void generateRays(Camera& camera, unsigned int width, unsigned int height, std::vector<Ray>& rays);
+
+    size_t size() const;
+
+private:
+    struct Node {
+        glm::vec3 bounds_min;
+        uint32_t first; // first child if count == 0, first primitive otherwise
+        glm::vec3 bounds_max;
+        uint16_t count;
+        uint16_t axis;
+    };
+
+    void build(uint32_t node_index, uint32_t begin, uint32_t end);
+    void refit();
+    float cost() const;
+
+    RayHit makeHit(const Ray& ray, float t, int index) const;
+
+    std::vector<glm::vec4> instances;
+    std::vector<glm::vec4> leaf_spheres; // instances in leaf order
+    std::vector<uint32_t> prim_indices;
+    std::vector<Node> nodes;
+
+    float build_cost = 0.0f;
+    bool dirty = false;
+
+    static const uint32_t max_leaf_size = 4;
+    static const int max_depth = 64;
+};
+
+#endif
@@ -14,6 +14,10 @@ public:
     ~Sphere();
 
     void draw();
+    void setInstances(const float* offsets, size_t count); // xyz per instance, vertex attribute 2
+    void drawInstanced();
+
+    size_t getTriangleCount();
 
     void print_vertices();
     void print_indices();
@@ -26,4 +30,7 @@ private:
     size_t indices_length;
 
     unsigned int vao, vbo, ebo;
+
+    unsigned int instance_vbo = 0;
+    size_t nb_instances = 0;
 };
\ No newline at end of file
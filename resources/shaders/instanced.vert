@@ -0,0 +1,19 @@
+#version 460 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec3 aOffset; // per instance, (0, 0, 0) when not bound
+
+out vec3 FragPos;
+out vec3 Normal;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    vec4 world_pos = model * vec4(aPos, 1.0) + vec4(aOffset, 0.0);
+    gl_Position = projection * view * world_pos;
+    FragPos = vec3(world_pos);
+    Normal = aNormal;
+}
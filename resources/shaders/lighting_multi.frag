@@ -0,0 +1,37 @@
+# version 460 core
+#define MAX_LIGHTS 32
+
+in vec3 FragPos;
+in vec3 Normal;
+
+out vec4 FragColor;
+
+uniform vec3 object_color;
+uniform int nb_lights;
+uniform vec3 light_color[MAX_LIGHTS];
+uniform vec3 light_pos[MAX_LIGHTS];
+uniform vec3 view_pos;
+
+void main() {
+	vec3 norm = normalize(Normal);
+	vec3 view_direction = normalize(view_pos - FragPos);
+
+	vec3 result = vec3(0.0);
+	for (int i = 0; i < nb_lights; ++i) {
+		// ambient
+		float ambient_strength = 0.1;
+		vec3 ambient = ambient_strength * light_color[i];
+
+		// difuse
+		vec3 light_direction = normalize(light_pos[i] - FragPos);
+		vec3 diffuse = max(dot(norm, light_direction), 0.0) * light_color[i];
+
+		// specular
+		float specular_strength = 0.5;
+		vec3 reflect_direction = reflect(-light_direction, norm);
+		vec3 specular = pow(max(dot(view_direction, reflect_direction), 0.0), 32) * light_color[i] * specular_strength;
+
+		result += (ambient + diffuse + specular) * object_color;
+	}
+	FragColor = vec4(result, 1.0);
+}
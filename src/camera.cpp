@@ -78,6 +78,19 @@ void Camera::zoom(float yoffset) {
     }
 }
 
+void Camera::setPose(glm::vec3 pos, float new_yaw, float new_pitch, float new_fov) {
+    camera_pos = pos;
+    yaw = new_yaw;
+    pitch = glm::clamp(new_pitch, -89.0f, 89.0f);
+    fov = glm::clamp(new_fov, 1.0f, 45.0f);
+    glm::vec3 direction = glm::vec3(
+        cos(glm::radians(yaw)) * cos(glm::radians(pitch)),
+        sin(glm::radians(pitch)),
+        sin(glm::radians(yaw)) * cos(glm::radians(pitch))
+    );
+    camera_front = glm::normalize(direction);
+}
+
 glm::mat4 Camera::getViewMatrix() {
     return glm::lookAt(
         camera_pos, camera_pos + camera_front, camera_up
@@ -88,6 +101,14 @@ float Camera::getFOV() {
     return fov;
 }
 
+float Camera::getYaw() {
+    return yaw;
+}
+
+float Camera::getPitch() {
+    return pitch;
+}
+
 glm::vec3 Camera::getCoords() {
     return camera_pos;
 }
@@ -0,0 +1,121 @@
+#include "camera_path.hpp"
+#include "camera.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+CameraPath::CameraPath() {}
+
+bool CameraPath::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cout << "ERROR OPENING CAMERA PATH " << path << std::endl;
+        return false;
+    }
+
+    keyframes.clear();
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        std::istringstream stream(line);
+        CameraKeyframe k;
+        if (!(stream >> k.time >> k.position.x >> k.position.y >> k.position.z >> k.yaw >> k.pitch >> k.fov)) {
+            std::cout << "ERROR READING CAMERA PATH " << path << ":" << line_number << std::endl;
+            keyframes.clear();
+            return false;
+        }
+        if (!keyframes.empty() && k.time < keyframes.back().time) {
+            std::cout << "ERROR CAMERA PATH TIME GOES BACKWARD " << path << ":" << line_number << std::endl;
+            keyframes.clear();
+            return false;
+        }
+        keyframes.push_back(k);
+    }
+    return true;
+}
+
+bool CameraPath::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cout << "ERROR WRITING CAMERA PATH " << path << std::endl;
+        return false;
+    }
+    // enough digits to reload exactly the recorded floats
+    file << std::setprecision(std::numeric_limits<float>::max_digits10);
+    file << "# time x y z yaw pitch fov" << std::endl;
+    for (const CameraKeyframe& k : keyframes) {
+        file << k.time << " " << k.position.x << " " << k.position.y << " " << k.position.z << " "
+             << k.yaw << " " << k.pitch << " " << k.fov << std::endl;
+    }
+    return true;
+}
+
+void CameraPath::record(float time, Camera& camera) {
+    keyframes.push_back({ time, camera.getCoords(), camera.getYaw(), camera.getPitch(), camera.getFOV() });
+}
+
+void CameraPath::apply(float time, Camera& camera) const {
+    if (keyframes.empty()) return;
+
+    auto next = std::upper_bound(
+        keyframes.begin(), keyframes.end(), time,
+        [](float t, const CameraKeyframe& k) { return t < k.time; }
+    );
+    if (next == keyframes.begin()) {
+        const CameraKeyframe& k = keyframes.front();
+        camera.setPose(k.position, k.yaw, k.pitch, k.fov);
+        return;
+    }
+    if (next == keyframes.end()) {
+        const CameraKeyframe& k = keyframes.back();
+        camera.setPose(k.position, k.yaw, k.pitch, k.fov);
+        return;
+    }
+
+    const CameraKeyframe& a = *(next - 1);
+    const CameraKeyframe& b = *next;
+    float span = b.time - a.time;
+    float s = span > 0.0f ? (time - a.time) / span : 1.0f;
+    camera.setPose(
+        glm::mix(a.position, b.position, s),
+        glm::mix(a.yaw, b.yaw, s),
+        glm::mix(a.pitch, b.pitch, s),
+        glm::mix(a.fov, b.fov, s)
+    );
+}
+
+float CameraPath::duration() const {
+    return keyframes.empty() ? 0.0f : keyframes.back().time;
+}
+
+bool CameraPath::empty() const {
+    return keyframes.empty();
+}
+
+CameraPath CameraPath::orbit(glm::vec3 center, float distance, float height, float duration) {
+    const int nb_keyframes = 73; // every 5 degrees
+    CameraPath path;
+    for (int i = 0; i < nb_keyframes; ++i) {
+        float s = static_cast<float>(i) / (nb_keyframes - 1);
+        float angle = s * 360.0f;
+        glm::vec3 position = center + glm::vec3(
+            distance * cos(glm::radians(angle)),
+            height,
+            distance * sin(glm::radians(angle))
+        );
+        // look back at the center, yaw kept continuous so interpolation never wraps
+        glm::vec3 front = glm::normalize(center - position);
+        float yaw = angle + 180.0f;
+        float pitch = glm::degrees(asin(front.y));
+        path.keyframes.push_back({ s * duration, position, yaw, pitch, 45.0f });
+    }
+    return path;
+}
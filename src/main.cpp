@@ -2,6 +2,8 @@
 #include "stb_image.h"
 #include "camera.hpp"
 #include "sphere.hpp"
+#include "query.hpp"
+#include "camera_path.hpp"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -14,6 +16,7 @@
 #include <cmath>
 #include <fstream>
 #include <memory>
+#include <string>
 
 unsigned int SCR_WIDTH = 900;
 unsigned int SCR_HEIGHT = 900;
@@ -22,12 +25,20 @@ const float mouse_sensitivity = 0.03f;
 
 auto camera = Camera(glm::vec3(0.0f, 2.0f, 5.0f)); // global for now but should be placed in a window class
 
+SphereQuery scene_query; // bounding spheres of the scene objects, for picking
+
 float last_mouse_x = 0.0f;
 float last_mouse_y = 0.0f;
 
 float delta_time = 0.0f;
 float last_frame = 0.0f;
 
+// --record <file> saves the camera path on exit, --replay <file> plays it back
+CameraPath camera_path;
+bool recording = false;
+bool replaying = false;
+const float replay_step = 1.0f / 60.0f; // fixed timestep, independent of the frame rate
+
 void frame_buffer_size_callback(GLFWwindow* window, int width, int height) {
     SCR_HEIGHT = height;
     SCR_WIDTH = width;
@@ -46,7 +57,7 @@ void mouseMotionCallback(GLFWwindow* window, double xpos, double ypos) {
 
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (action == GLFW_RELEASE) return; // only handle press events
-    if (key == GLFW_KEY_1) {
+    if (key == GLFW_KEY_1 && !replaying) {
         if (glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED) {
             glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
             camera.disable();
@@ -58,6 +69,25 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
     }
 }
 
+void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+    if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS) return;
+    if (glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED) return; // no cursor to pick with
+    double xpos, ypos;
+    glfwGetCursorPos(window, &xpos, &ypos);
+    // the cursor is in window coordinates, which differ from framebuffer pixels on HiDPI displays
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    if (width == 0 || height == 0) return;
+    Ray ray = SphereQuery::rayFromScreen(
+        camera, static_cast<float>(xpos), static_cast<float>(ypos),
+        static_cast<float>(width), static_cast<float>(height)
+    );
+    RayHit hit = scene_query.intersect(ray);
+    if (hit.hit) {
+        std::cout << "picked object " << hit.instance << " at distance " << hit.distance << std::endl;
+    }
+}
+
 void processInput(GLFWwindow* window, Camera& camera) {
 
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
@@ -85,7 +115,31 @@ void processInput(GLFWwindow* window, Camera& camera) {
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
+    std::string camera_path_file;
+    const char* usage = "usage: opengl_tutorials [--record <file> | --replay <file>]";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg != "--record" && arg != "--replay") {
+            std::cout << "unknown argument " << arg << "\n" << usage << std::endl;
+            return -1;
+        }
+        if (i + 1 >= argc) {
+            std::cout << "missing file for " << arg << "\n" << usage << std::endl;
+            return -1;
+        }
+        recording = recording || arg == "--record";
+        replaying = replaying || arg == "--replay";
+        camera_path_file = argv[++i];
+    }
+    if (recording && replaying) {
+        std::cout << "--record and --replay can't be used together\n" << usage << std::endl;
+        return -1;
+    }
+    if (replaying && !camera_path.load(camera_path_file)) {
+        return -1;
+    }
+
     stbi_set_flip_vertically_on_load(true);
 
     glfwInit();
@@ -110,9 +164,13 @@ int main() {
 
     glfwSetCursorPosCallback(window, mouseMotionCallback);
     glfwSetKeyCallback(window, keyCallback);
+    glfwSetMouseButtonCallback(window, mouseButtonCallback);
     glfwSetFramebufferSizeCallback(window, frame_buffer_size_callback);
 
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (replaying) {
+        camera.disable(); // mouse and keyboard don't move the camera, the path does
+    }
 
     auto sphere = std::make_unique<Sphere>(50, 2.0f);
 
@@ -194,6 +252,14 @@ int main() {
 
     glm::vec3 light_color = glm::vec3(1.0f, 1.0f, 1.0f);
 
+    float replay_time = 0.0f;
+    float record_start = static_cast<float>(glfwGetTime());
+
+    scene_query.setInstances({
+        glm::vec4(0.0f, 0.0f, 0.0f, 2.0f), // sphere
+        glm::vec4(light_pos, std::sqrt(3.0f) / 2.0f) // light cube
+    });
+
     while (!glfwWindowShouldClose(window)) {
         time = static_cast<float>(glfwGetTime());
         delta_time = time - last_frame;
@@ -201,6 +267,16 @@ int main() {
 
         processInput(window, camera);
 
+        if (replaying) {
+            camera_path.apply(replay_time, camera);
+            replay_time += replay_step;
+            if (replay_time > camera_path.duration() + replay_step) {
+                glfwSetWindowShouldClose(window, true);
+            }
+        } else if (recording) {
+            camera_path.record(time - record_start, camera);
+        }
+
         //glm::vec3 light_color = glm::vec3(1.0f, 1.0f, 0.5 + sin(time)/2);
 
         view = camera.getViewMatrix();
@@ -239,5 +315,9 @@ int main() {
     }
 
     glfwTerminate();
+
+    if (recording) {
+        camera_path.save(camera_path_file);
+    }
     return 0;
 }
\ No newline at end of file
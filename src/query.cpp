@@ -0,0 +1,398 @@
+#include "query.hpp"
+#include "camera.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUERY_SSE
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const float ray_epsilon = 1e-4f;
+
+// rebuild when the refitted tree costs this much more than a fresh one
+const float rebuild_ratio = 1.5f;
+
+// avoid 0 * inf = NaN in the slab test when a ray is parallel to an axis
+float safeInverse(float d) {
+    const float tiny = 1e-20f;
+    if (std::fabs(d) < tiny) {
+        d = d < 0.0f ? -tiny : tiny;
+    }
+    return 1.0f / d;
+}
+
+float surfaceArea(glm::vec3 bounds_min, glm::vec3 bounds_max) {
+    glm::vec3 e = bounds_max - bounds_min;
+    return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+// nearest t > epsilon, or INFINITY
+float intersectSphere(const Ray& ray, glm::vec4 sphere) {
+    glm::vec3 oc = ray.origin - glm::vec3(sphere);
+    float b = glm::dot(oc, ray.direction);
+    float c = glm::dot(oc, oc) - sphere.w * sphere.w;
+    float disc = b * b - c;
+    if (disc < 0.0f) return INFINITY;
+    float s = std::sqrt(disc);
+    float t = -b - s;
+    if (t > ray_epsilon) return t;
+    t = -b + s; // origin inside the sphere
+    if (t > ray_epsilon) return t;
+    return INFINITY;
+}
+
+// same projection as the render loop in main.cpp
+glm::mat4 inverseViewProjection(Camera& camera, float width, float height) {
+    glm::mat4 projection = glm::perspective(camera.getFOV(), width / height, 0.1f, 100.0f);
+    return glm::inverse(projection * camera.getViewMatrix());
+}
+
+Ray unproject(const glm::mat4& inv, glm::vec3 origin, float x, float y, float width, float height) {
+    float ndc_x = 2.0f * x / width - 1.0f;
+    float ndc_y = 1.0f - 2.0f * y / height;
+    glm::vec4 far_point = inv * glm::vec4(ndc_x, ndc_y, 1.0f, 1.0f);
+    glm::vec3 target = glm::vec3(far_point) / far_point.w;
+    return Ray{ origin, glm::normalize(target - origin) };
+}
+
+} // namespace
+
+SphereQuery::SphereQuery() {}
+
+void SphereQuery::setInstances(const std::vector<glm::vec4>& spheres) {
+    instances = spheres;
+    rebuild();
+}
+
+void SphereQuery::setInstance(size_t index, glm::vec3 center, float radius) {
+    assert(index < instances.size());
+    instances[index] = glm::vec4(center, radius);
+    dirty = true;
+}
+
+size_t SphereQuery::size() const {
+    return instances.size();
+}
+
+void SphereQuery::rebuild() {
+    nodes.clear();
+    leaf_spheres.clear();
+    prim_indices.resize(instances.size());
+    for (size_t i = 0; i < prim_indices.size(); ++i) {
+        prim_indices[i] = static_cast<uint32_t>(i);
+    }
+    dirty = false;
+    build_cost = 0.0f;
+    if (instances.empty()) return;
+
+    nodes.reserve(2 * instances.size() / max_leaf_size + 1);
+    nodes.push_back(Node());
+    build(0, 0, static_cast<uint32_t>(instances.size()));
+
+    leaf_spheres.resize(instances.size());
+    for (size_t i = 0; i < prim_indices.size(); ++i) {
+        leaf_spheres[i] = instances[prim_indices[i]];
+    }
+    build_cost = cost();
+}
+
+// median split on the longest centroid axis: cheap and keeps the tree balanced,
+// so traversal never exceeds max_depth
+void SphereQuery::build(uint32_t node_index, uint32_t begin, uint32_t end) {
+    glm::vec3 bounds_min(INFINITY), bounds_max(-INFINITY);
+    glm::vec3 centroid_min(INFINITY), centroid_max(-INFINITY);
+    for (uint32_t i = begin; i < end; ++i) {
+        glm::vec4 s = instances[prim_indices[i]];
+        glm::vec3 c = glm::vec3(s);
+        bounds_min = glm::min(bounds_min, c - s.w);
+        bounds_max = glm::max(bounds_max, c + s.w);
+        centroid_min = glm::min(centroid_min, c);
+        centroid_max = glm::max(centroid_max, c);
+    }
+    nodes[node_index].bounds_min = bounds_min;
+    nodes[node_index].bounds_max = bounds_max;
+
+    if (end - begin <= max_leaf_size) {
+        nodes[node_index].first = begin;
+        nodes[node_index].count = static_cast<uint16_t>(end - begin);
+        nodes[node_index].axis = 0;
+        return;
+    }
+
+    glm::vec3 extent = centroid_max - centroid_min;
+    int axis = 0;
+    if (extent.y > extent.x) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+
+    uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(
+        prim_indices.begin() + begin, prim_indices.begin() + mid, prim_indices.begin() + end,
+        [this, axis](uint32_t a, uint32_t b) { return instances[a][axis] < instances[b][axis]; }
+    );
+
+    // children are allocated next to each other, after their parent
+    uint32_t left = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(Node());
+    nodes.push_back(Node());
+    nodes[node_index].first = left;
+    nodes[node_index].count = 0;
+    nodes[node_index].axis = static_cast<uint16_t>(axis);
+
+    build(left, begin, mid);
+    build(left + 1, mid, end);
+}
+
+bool SphereQuery::update() {
+    if (!dirty) return false;
+    dirty = false;
+    if (nodes.empty()) return false;
+
+    for (size_t i = 0; i < prim_indices.size(); ++i) {
+        leaf_spheres[i] = instances[prim_indices[i]];
+    }
+    refit();
+    if (cost() > rebuild_ratio * build_cost) {
+        rebuild();
+        return true;
+    }
+    return false;
+}
+
+// children always have a greater index than their parent
+void SphereQuery::refit() {
+    for (size_t i = nodes.size(); i-- > 0;) {
+        Node& node = nodes[i];
+        if (node.count > 0) {
+            glm::vec3 bounds_min(INFINITY), bounds_max(-INFINITY);
+            for (uint32_t k = node.first; k < node.first + node.count; ++k) {
+                glm::vec4 s = leaf_spheres[k];
+                bounds_min = glm::min(bounds_min, glm::vec3(s) - s.w);
+                bounds_max = glm::max(bounds_max, glm::vec3(s) + s.w);
+            }
+            node.bounds_min = bounds_min;
+            node.bounds_max = bounds_max;
+        } else {
+            const Node& left = nodes[node.first];
+            const Node& right = nodes[node.first + 1];
+            node.bounds_min = glm::min(left.bounds_min, right.bounds_min);
+            node.bounds_max = glm::max(left.bounds_max, right.bounds_max);
+        }
+    }
+}
+
+// SAH style estimate: sum of the node areas relative to the root
+float SphereQuery::cost() const {
+    float root_area = surfaceArea(nodes[0].bounds_min, nodes[0].bounds_max);
+    if (root_area <= 0.0f) return 0.0f;
+    float total = 0.0f;
+    for (const Node& node : nodes) {
+        total += surfaceArea(node.bounds_min, node.bounds_max);
+    }
+    return total / root_area;
+}
+
+RayHit SphereQuery::makeHit(const Ray& ray, float t, int index) const {
+    RayHit hit;
+    if (index < 0) return hit;
+    glm::vec4 s = instances[index];
+    hit.hit = true;
+    hit.distance = t;
+    hit.instance = index;
+    hit.normal = (ray.origin + t * ray.direction - glm::vec3(s)) / s.w;
+    return hit;
+}
+
+RayHit SphereQuery::intersectBruteForce(const Ray& ray) const {
+    float t_best = INFINITY;
+    int best = -1;
+    for (size_t i = 0; i < instances.size(); ++i) {
+        float t = intersectSphere(ray, instances[i]);
+        if (t < t_best) {
+            t_best = t;
+            best = static_cast<int>(i);
+        }
+    }
+    return makeHit(ray, t_best, best);
+}
+
+RayHit SphereQuery::intersect(const Ray& ray) const {
+    assert(!dirty && "call update() after setInstance()");
+    if (nodes.empty()) return RayHit();
+
+    glm::vec3 inv_dir(safeInverse(ray.direction.x), safeInverse(ray.direction.y), safeInverse(ray.direction.z));
+    float t_best = INFINITY;
+    int best = -1;
+
+    uint32_t stack[max_depth];
+    int sp = 0;
+    stack[sp++] = 0;
+    while (sp > 0) {
+        const Node& node = nodes[stack[--sp]];
+
+        glm::vec3 t1 = (node.bounds_min - ray.origin) * inv_dir;
+        glm::vec3 t2 = (node.bounds_max - ray.origin) * inv_dir;
+        glm::vec3 t_near = glm::min(t1, t2);
+        glm::vec3 t_far = glm::max(t1, t2);
+        float t_enter = std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, 0.0f));
+        float t_exit = std::min(std::min(t_far.x, t_far.y), std::min(t_far.z, t_best));
+        if (t_enter > t_exit) continue;
+
+        if (node.count > 0) {
+            for (uint32_t k = node.first; k < node.first + node.count; ++k) {
+                float t = intersectSphere(ray, leaf_spheres[k]);
+                if (t < t_best) {
+                    t_best = t;
+                    best = static_cast<int>(prim_indices[k]);
+                }
+            }
+        } else {
+            // push the far child first so the near one is visited first
+            bool negative = ray.direction[node.axis] < 0.0f;
+            stack[sp++] = node.first + (negative ? 0 : 1);
+            stack[sp++] = node.first + (negative ? 1 : 0);
+        }
+    }
+    return makeHit(ray, t_best, best);
+}
+
+#ifdef QUERY_SSE
+
+void SphereQuery::intersectPacket(const Ray* rays, RayHit* hits) const {
+    assert(!dirty && "call update() after setInstance()");
+    if (nodes.empty()) {
+        for (int i = 0; i < 4; ++i) hits[i] = RayHit();
+        return;
+    }
+
+    const __m128 ox = _mm_setr_ps(rays[0].origin.x, rays[1].origin.x, rays[2].origin.x, rays[3].origin.x);
+    const __m128 oy = _mm_setr_ps(rays[0].origin.y, rays[1].origin.y, rays[2].origin.y, rays[3].origin.y);
+    const __m128 oz = _mm_setr_ps(rays[0].origin.z, rays[1].origin.z, rays[2].origin.z, rays[3].origin.z);
+    const __m128 dx = _mm_setr_ps(rays[0].direction.x, rays[1].direction.x, rays[2].direction.x, rays[3].direction.x);
+    const __m128 dy = _mm_setr_ps(rays[0].direction.y, rays[1].direction.y, rays[2].direction.y, rays[3].direction.y);
+    const __m128 dz = _mm_setr_ps(rays[0].direction.z, rays[1].direction.z, rays[2].direction.z, rays[3].direction.z);
+    const __m128 idx = _mm_setr_ps(
+        safeInverse(rays[0].direction.x), safeInverse(rays[1].direction.x),
+        safeInverse(rays[2].direction.x), safeInverse(rays[3].direction.x));
+    const __m128 idy = _mm_setr_ps(
+        safeInverse(rays[0].direction.y), safeInverse(rays[1].direction.y),
+        safeInverse(rays[2].direction.y), safeInverse(rays[3].direction.y));
+    const __m128 idz = _mm_setr_ps(
+        safeInverse(rays[0].direction.z), safeInverse(rays[1].direction.z),
+        safeInverse(rays[2].direction.z), safeInverse(rays[3].direction.z));
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 epsilon = _mm_set1_ps(ray_epsilon);
+    __m128 t_best = _mm_set1_ps(INFINITY);
+    __m128i best = _mm_set1_epi32(-1);
+
+    // the packet is ordered by the direction of its first ray
+    const float* d0 = &rays[0].direction.x;
+
+    uint32_t stack[max_depth];
+    int sp = 0;
+    stack[sp++] = 0;
+    while (sp > 0) {
+        const Node& node = nodes[stack[--sp]];
+
+        __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds_min.x), ox), idx);
+        __m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds_max.x), ox), idx);
+        __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds_min.y), oy), idy);
+        __m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds_max.y), oy), idy);
+        __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds_min.z), oz), idz);
+        __m128 t2z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds_max.z), oz), idz);
+        __m128 t_enter = _mm_max_ps(
+            _mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y)),
+            _mm_max_ps(_mm_min_ps(t1z, t2z), zero));
+        __m128 t_exit = _mm_min_ps(
+            _mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y)),
+            _mm_min_ps(_mm_max_ps(t1z, t2z), t_best));
+        if (_mm_movemask_ps(_mm_cmple_ps(t_enter, t_exit)) == 0) continue;
+
+        if (node.count > 0) {
+            for (uint32_t k = node.first; k < node.first + node.count; ++k) {
+                const glm::vec4& s = leaf_spheres[k];
+                __m128 ocx = _mm_sub_ps(ox, _mm_set1_ps(s.x));
+                __m128 ocy = _mm_sub_ps(oy, _mm_set1_ps(s.y));
+                __m128 ocz = _mm_sub_ps(oz, _mm_set1_ps(s.z));
+                __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, dx), _mm_mul_ps(ocy, dy)), _mm_mul_ps(ocz, dz));
+                __m128 c = _mm_sub_ps(
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, ocx), _mm_mul_ps(ocy, ocy)), _mm_mul_ps(ocz, ocz)),
+                    _mm_set1_ps(s.w * s.w));
+                __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), c);
+                __m128 valid = _mm_cmpge_ps(disc, zero);
+                if (_mm_movemask_ps(valid) == 0) continue;
+
+                __m128 root = _mm_sqrt_ps(_mm_max_ps(disc, zero));
+                __m128 t_in = _mm_sub_ps(_mm_sub_ps(zero, b), root);
+                __m128 t_out = _mm_add_ps(_mm_sub_ps(zero, b), root);
+                // use the exit distance when the origin is inside the sphere
+                __m128 use_in = _mm_cmpgt_ps(t_in, epsilon);
+                __m128 t = _mm_or_ps(_mm_and_ps(use_in, t_in), _mm_andnot_ps(use_in, t_out));
+                valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpgt_ps(t, epsilon), _mm_cmplt_ps(t, t_best)));
+                if (_mm_movemask_ps(valid) == 0) continue;
+
+                t_best = _mm_or_ps(_mm_and_ps(valid, t), _mm_andnot_ps(valid, t_best));
+                __m128i mask = _mm_castps_si128(valid);
+                __m128i index = _mm_set1_epi32(static_cast<int>(prim_indices[k]));
+                best = _mm_or_si128(_mm_and_si128(mask, index), _mm_andnot_si128(mask, best));
+            }
+        } else {
+            bool negative = d0[node.axis] < 0.0f;
+            stack[sp++] = node.first + (negative ? 0 : 1);
+            stack[sp++] = node.first + (negative ? 1 : 0);
+        }
+    }
+
+    alignas(16) float t_out[4];
+    alignas(16) int index_out[4];
+    _mm_store_ps(t_out, t_best);
+    _mm_store_si128(reinterpret_cast<__m128i*>(index_out), best);
+    for (int i = 0; i < 4; ++i) {
+        hits[i] = makeHit(rays[i], t_out[i], index_out[i]);
+    }
+}
+
+#else
+
+void SphereQuery::intersectPacket(const Ray* rays, RayHit* hits) const {
+    for (int i = 0; i < 4; ++i) {
+        hits[i] = intersect(rays[i]);
+    }
+}
+
+#endif
+
+void SphereQuery::intersect(const std::vector<Ray>& rays, std::vector<RayHit>& hits) const {
+    hits.resize(rays.size());
+    size_t i = 0;
+    for (; i + 4 <= rays.size(); i += 4) {
+        intersectPacket(&rays[i], &hits[i]);
+    }
+    for (; i < rays.size(); ++i) {
+        hits[i] = intersect(rays[i]);
+    }
+}
+
+Ray SphereQuery::rayFromScreen(Camera& camera, float x, float y, float width, float height) {
+    glm::mat4 inv = inverseViewProjection(camera, width, height);
+    return unproject(inv, camera.getCoords(), x, y, width, height);
+}
+
+void SphereQuery::generateRays(Camera& camera, unsigned int width, unsigned int height, std::vector<Ray>& rays) {
+    float w = static_cast<float>(width);
+    float h = static_cast<float>(height);
+    glm::mat4 inv = inverseViewProjection(camera, w, h);
+    glm::vec3 origin = camera.getCoords();
+
+    rays.resize(static_cast<size_t>(width) * height);
+    size_t k = 0;
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            rays[k++] = unproject(inv, origin, x + 0.5f, y + 0.5f, w, h);
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#include "query.hpp"
+#include "camera.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// usage: query_benchmark [nb_instances] [resolution]
+// prints build/refit times and Mrays/s for the BVH (scalar and packets) and the
+// brute force reference, and checks both agree. Returns 1 on mismatch.
+
+using bench_clock = std::chrono::steady_clock;
+
+double secondsSince(bench_clock::time_point start) {
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+bool sameHit(const RayHit& a, const RayHit& b) {
+    if (a.hit != b.hit) return false;
+    if (!a.hit || a.instance == b.instance) return true;
+    // two instances at (almost) the same distance
+    return std::fabs(a.distance - b.distance) < 1e-3f * std::max(1.0f, a.distance);
+}
+
+int main(int argc, char** argv) {
+    size_t nb_instances = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    unsigned int resolution = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 900;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> radius(0.1f, 0.5f);
+
+    std::vector<glm::vec4> spheres(nb_instances);
+    for (auto& s : spheres) {
+        s = glm::vec4(position(rng), position(rng), position(rng), radius(rng));
+    }
+
+    SphereQuery query;
+    auto start = bench_clock::now();
+    query.setInstances(spheres);
+    std::cout << "build " << nb_instances << " instances: " << secondsSince(start) * 1000.0 << " ms" << std::endl;
+
+    // move 10% of the instances a little, as an animation frame would
+    std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+    start = bench_clock::now();
+    for (size_t i = 0; i < nb_instances; i += 10) {
+        glm::vec4 s = spheres[i];
+        query.setInstance(i, glm::vec3(s) + glm::vec3(jitter(rng), jitter(rng), jitter(rng)), s.w);
+    }
+    query.update();
+    std::cout << "update: " << secondsSince(start) * 1000.0 << " ms" << std::endl;
+
+    auto camera = Camera(glm::vec3(0.0f, 2.0f, 60.0f));
+    std::vector<Ray> rays;
+    SphereQuery::generateRays(camera, resolution, resolution, rays);
+
+    std::vector<RayHit> scalar_hits(rays.size());
+    start = bench_clock::now();
+    for (size_t i = 0; i < rays.size(); ++i) {
+        scalar_hits[i] = query.intersect(rays[i]);
+    }
+    double scalar_time = secondsSince(start);
+
+    std::vector<RayHit> packet_hits;
+    start = bench_clock::now();
+    query.intersect(rays, packet_hits);
+    double packet_time = secondsSince(start);
+
+    // the brute force is too slow for every pixel, use a subset
+    const size_t stride = 97;
+    size_t nb_checked = 0;
+    size_t nb_mismatch = 0;
+    size_t nb_hits = 0;
+    start = bench_clock::now();
+    for (size_t i = 0; i < rays.size(); i += stride) {
+        RayHit reference = query.intersectBruteForce(rays[i]);
+        ++nb_checked;
+        nb_hits += reference.hit;
+        if (!sameHit(reference, scalar_hits[i]) || !sameHit(reference, packet_hits[i])) {
+            ++nb_mismatch;
+        }
+    }
+    double brute_time = secondsSince(start);
+
+    double nb_rays = static_cast<double>(rays.size());
+    std::cout << "rays: " << rays.size() << std::endl;
+    std::cout << "bvh scalar: " << nb_rays / scalar_time / 1e6 << " Mrays/s" << std::endl;
+    std::cout << "bvh packet: " << nb_rays / packet_time / 1e6 << " Mrays/s" << std::endl;
+    std::cout << "brute force: " << nb_checked / brute_time / 1e6 << " Mrays/s" << std::endl;
+    std::cout << "checked " << nb_checked << " rays (" << nb_hits << " hits), "
+              << nb_mismatch << " mismatches" << std::endl;
+
+    return nb_mismatch == 0 ? 0 : 1;
+}
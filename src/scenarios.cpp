@@ -0,0 +1,355 @@
+#include "shader.hpp"
+#include "camera.hpp"
+#include "camera_path.hpp"
+#include "sphere.hpp"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Headless performance scenarios. Each scenario replays a camera path with a
+// fixed timestep in a hidden window and reports frame time percentiles, draw
+// calls and triangles per frame as JSON.
+//
+// usage: scenario_suite [--out results.json] [--baseline baseline.json]
+//                       [--tolerance 0.1] [--frames 600] [--path camera.path]
+//
+// With --baseline, returns 1 if a frame time percentile is more than
+// tolerance above the baseline or if draw calls / triangles increased.
+// A results file can be used as the next baseline.
+
+const unsigned int SCR_WIDTH = 900;
+const unsigned int SCR_HEIGHT = 900;
+
+const int warmup_frames = 30;
+
+struct Scenario {
+    std::string name;
+    int nb_points;
+    int grid_size; // instances on a grid_size x grid_size field, 0 for a single sphere
+    int nb_lights;
+    float orbit_distance;
+};
+
+struct ScenarioResult {
+    std::string name;
+    int frames = 0;
+    long long draw_calls = 0;
+    long long triangles = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+const std::vector<Scenario> scenarios = {
+    { "sphere_20", 20, 0, 1, 6.0f },
+    { "sphere_50", 50, 0, 1, 6.0f },
+    { "sphere_200", 200, 0, 1, 6.0f },
+    { "sphere_1000", 1000, 0, 1, 6.0f },
+    { "field_32x32", 20, 32, 1, 60.0f },
+    { "field_100x100", 20, 100, 1, 160.0f },
+    { "lights_8", 50, 0, 8, 6.0f },
+    { "lights_32", 50, 0, 32, 6.0f },
+};
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+ScenarioResult runScenario(const Scenario& scenario, Shader& light_source_shader, Shader& light_shader,
+                           const CameraPath* custom_path, int nb_frames) {
+    ScenarioResult result;
+    result.name = scenario.name;
+    result.frames = nb_frames;
+
+    auto sphere = std::make_unique<Sphere>(scenario.nb_points, 2.0f);
+    auto light_marker = std::make_unique<Sphere>(8, 0.25f);
+
+    int nb_instances = 1;
+    if (scenario.grid_size > 0) {
+        nb_instances = scenario.grid_size * scenario.grid_size;
+        std::vector<float> offsets;
+        offsets.reserve(nb_instances * 3);
+        const float spacing = 5.0f;
+        float half = (scenario.grid_size - 1) * spacing / 2.0f;
+        for (int i = 0; i < scenario.grid_size; ++i) {
+            for (int j = 0; j < scenario.grid_size; ++j) {
+                offsets.push_back(i * spacing - half);
+                offsets.push_back(0.0f);
+                offsets.push_back(j * spacing - half);
+            }
+        }
+        sphere->setInstances(offsets.data(), nb_instances);
+    }
+
+    std::vector<glm::vec3> light_pos(scenario.nb_lights);
+    std::vector<glm::vec3> light_color(scenario.nb_lights);
+    for (int i = 0; i < scenario.nb_lights; ++i) {
+        float angle = glm::radians(360.0f * i / scenario.nb_lights);
+        light_pos[i] = glm::vec3(4.0f * cos(angle), 4.0f, 4.0f * sin(angle));
+        light_color[i] = glm::vec3(1.0f) / static_cast<float>(scenario.nb_lights);
+    }
+
+    CameraPath path = custom_path ? *custom_path : CameraPath::orbit(
+        glm::vec3(0.0f), scenario.orbit_distance, scenario.orbit_distance / 3.0f, 10.0f
+    );
+    const float fixed_step = path.duration() / nb_frames;
+
+    // the lights don't move, set them outside of the timed frames
+    light_shader.use();
+    light_shader.setInt("nb_lights", scenario.nb_lights);
+    for (int i = 0; i < scenario.nb_lights; ++i) {
+        light_shader.setVec3("light_pos[" + std::to_string(i) + "]", light_pos[i]);
+        light_shader.setVec3("light_color[" + std::to_string(i) + "]", light_color[i]);
+    }
+
+    auto camera = Camera();
+    std::vector<double> frame_times;
+    frame_times.reserve(nb_frames);
+
+    for (int frame = -warmup_frames; frame < nb_frames; ++frame) {
+        auto start = std::chrono::steady_clock::now();
+        long long draw_calls = 0;
+        long long triangles = 0;
+
+        path.apply(std::max(frame, 0) * fixed_step, camera);
+        glm::mat4 view = camera.getViewMatrix();
+        glm::mat4 projection = glm::perspective(
+            camera.getFOV(), static_cast<float>(SCR_WIDTH) / SCR_HEIGHT, 0.1f, 1000.0f
+        );
+
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+        light_source_shader.use();
+        light_source_shader.setMat4("view", view);
+        light_source_shader.setMat4("projection", projection);
+        for (int i = 0; i < scenario.nb_lights; ++i) {
+            light_source_shader.setMat4("model", glm::translate(glm::mat4(1.0f), light_pos[i]));
+            light_source_shader.setVec3("color", glm::vec3(1.0f));
+            light_marker->draw();
+            ++draw_calls;
+            triangles += light_marker->getTriangleCount();
+        }
+
+        light_shader.use();
+        light_shader.setMat4("view", view);
+        light_shader.setMat4("projection", projection);
+        light_shader.setMat4("model", glm::mat4(1.0f));
+        light_shader.setVec3("object_color", 0.4f, 0.1f, 0.6f);
+        light_shader.setVec3("view_pos", camera.getCoords());
+        if (scenario.grid_size > 0) {
+            sphere->drawInstanced();
+        } else {
+            sphere->draw();
+        }
+        ++draw_calls;
+        triangles += sphere->getTriangleCount() * nb_instances;
+
+        glFinish(); // wait for the GPU so the frame time includes rendering
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (frame >= 0) {
+            frame_times.push_back(ms);
+            result.draw_calls = draw_calls;
+            result.triangles = triangles;
+        }
+        glfwPollEvents();
+    }
+
+    double total = 0.0;
+    for (double t : frame_times) total += t;
+    std::sort(frame_times.begin(), frame_times.end());
+    result.mean = frame_times.empty() ? 0.0 : total / frame_times.size();
+    result.p50 = percentile(frame_times, 0.50);
+    result.p90 = percentile(frame_times, 0.90);
+    result.p99 = percentile(frame_times, 0.99);
+    result.max = frame_times.empty() ? 0.0 : frame_times.back();
+    return result;
+}
+
+void writeJson(std::ostream& out, const std::vector<ScenarioResult>& results) {
+    out << "{\n  \"scenarios\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const ScenarioResult& r = results[i];
+        out << "    {\n"
+            << "      \"name\": \"" << r.name << "\",\n"
+            << "      \"frames\": " << r.frames << ",\n"
+            << "      \"draw_calls\": " << r.draw_calls << ",\n"
+            << "      \"triangles\": " << r.triangles << ",\n"
+            << "      \"frame_time_ms\": { \"mean\": " << r.mean << ", \"p50\": " << r.p50
+            << ", \"p90\": " << r.p90 << ", \"p99\": " << r.p99 << ", \"max\": " << r.max << " }\n"
+            << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}" << std::endl;
+}
+
+bool findNumber(const std::string& text, const std::string& key, double& value) {
+    size_t pos = text.find("\"" + key + "\"");
+    if (pos == std::string::npos) return false;
+    pos = text.find(':', pos);
+    if (pos == std::string::npos) return false;
+    value = std::strtod(text.c_str() + pos + 1, nullptr);
+    return true;
+}
+
+// reads the format written by writeJson, not arbitrary JSON
+std::map<std::string, std::string> readBaseline(const std::string& path) {
+    std::map<std::string, std::string> entries; // scenario name -> its JSON text
+    std::ifstream file(path);
+    if (!file) {
+        std::cout << "ERROR OPENING BASELINE " << path << std::endl;
+        return entries;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    std::string text = stream.str();
+
+    const std::string name_key = "\"name\"";
+    size_t pos = text.find(name_key);
+    while (pos != std::string::npos) {
+        size_t next = text.find(name_key, pos + name_key.size());
+        size_t begin = text.find('"', text.find(':', pos) + 1);
+        size_t end = text.find('"', begin + 1);
+        if (begin == std::string::npos || end == std::string::npos) break;
+        entries[text.substr(begin + 1, end - begin - 1)] = text.substr(end, next == std::string::npos ? std::string::npos : next - end);
+        pos = next;
+    }
+    return entries;
+}
+
+int compareWithBaseline(const std::vector<ScenarioResult>& results, const std::string& path, double tolerance) {
+    auto baseline = readBaseline(path);
+    if (baseline.empty()) return 1;
+
+    int nb_regressions = 0;
+    for (const ScenarioResult& r : results) {
+        auto entry = baseline.find(r.name);
+        if (entry == baseline.end()) {
+            std::cerr << r.name << ": no baseline" << std::endl;
+            continue;
+        }
+        const std::string& text = entry->second;
+
+        const std::pair<const char*, double> times[] = { { "p50", r.p50 }, { "p90", r.p90 }, { "p99", r.p99 } };
+        for (const auto& [key, current] : times) {
+            double reference;
+            if (findNumber(text, key, reference) && current > reference * (1.0 + tolerance)) {
+                std::cerr << "REGRESSION " << r.name << " " << key << ": "
+                          << current << " ms (baseline " << reference << " ms)" << std::endl;
+                ++nb_regressions;
+            }
+        }
+
+        const std::pair<const char*, long long> counts[] = { { "draw_calls", r.draw_calls }, { "triangles", r.triangles } };
+        for (const auto& [key, current] : counts) {
+            double reference;
+            if (findNumber(text, key, reference) && current > static_cast<long long>(reference)) {
+                std::cerr << "REGRESSION " << r.name << " " << key << ": "
+                          << current << " (baseline " << static_cast<long long>(reference) << ")" << std::endl;
+                ++nb_regressions;
+            }
+        }
+    }
+    std::cerr << nb_regressions << " regressions" << std::endl;
+    return nb_regressions == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    std::string out_path;
+    std::string baseline_path;
+    std::string camera_path;
+    double tolerance = 0.1;
+    int nb_frames = 600;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cout << "missing value for " << arg << std::endl;
+            return 2;
+        }
+        if (arg == "--out") {
+            out_path = argv[++i];
+        } else if (arg == "--baseline") {
+            baseline_path = argv[++i];
+        } else if (arg == "--tolerance") {
+            tolerance = std::atof(argv[++i]);
+        } else if (arg == "--frames") {
+            nb_frames = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--path") {
+            camera_path = argv[++i];
+        } else {
+            std::cout << "unknown argument " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    CameraPath custom_path;
+    if (!camera_path.empty() && (!custom_path.load(camera_path) || custom_path.empty())) {
+        return 2;
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "scenarios", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+    glEnable(GL_DEPTH_TEST);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+    Shader light_source_shader("resources/shaders/3d.vert", "resources/shaders/light_source.frag");
+    Shader light_shader("resources/shaders/instanced.vert", "resources/shaders/lighting_multi.frag");
+
+    std::vector<ScenarioResult> results;
+    for (const Scenario& scenario : scenarios) {
+        std::cerr << "running " << scenario.name << std::endl;
+        results.push_back(runScenario(
+            scenario, light_source_shader, light_shader,
+            camera_path.empty() ? nullptr : &custom_path, nb_frames
+        ));
+    }
+
+    glfwTerminate();
+
+    writeJson(std::cout, results);
+    if (!out_path.empty()) {
+        std::ofstream out(out_path);
+        writeJson(out, results);
+    }
+
+    if (!baseline_path.empty()) {
+        return compareWithBaseline(results, baseline_path, tolerance);
+    }
+    return 0;
+}
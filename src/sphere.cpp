@@ -117,6 +117,9 @@ Sphere::~Sphere() {
     glDeleteVertexArrays(1, &vao);
     glDeleteBuffers(1, &vbo);
     glDeleteBuffers(1, &ebo);
+    if (instance_vbo != 0) {
+        glDeleteBuffers(1, &instance_vbo);
+    }
 }
 
 void Sphere::draw() {
@@ -124,6 +127,30 @@ void Sphere::draw() {
     glDrawElements(GL_TRIANGLES, indices_length, GL_UNSIGNED_INT, 0);
 }
 
+void Sphere::setInstances(const float* offsets, size_t count) {
+    glBindVertexArray(vao);
+    if (instance_vbo == 0) {
+        glGenBuffers(1, &instance_vbo);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, count * 3 * sizeof(float), offsets, GL_STATIC_DRAW);
+
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+
+    nb_instances = count;
+}
+
+void Sphere::drawInstanced() {
+    glBindVertexArray(vao);
+    glDrawElementsInstanced(GL_TRIANGLES, indices_length, GL_UNSIGNED_INT, 0, nb_instances);
+}
+
+size_t Sphere::getTriangleCount() {
+    return indices_length / 3;
+}
+
 void Sphere::print_vertices() {
     std::cout << "sphere vertices:" << std::endl;
     for (size_t i = 0; i < vertices_length; i += 6) {
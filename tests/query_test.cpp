@@ -0,0 +1,109 @@
+#include "query.hpp"
+#include "camera.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Checks SphereQuery against its brute force reference on every ray, after the
+// initial build, after a refit and after a rebuild triggered by update().
+// Returns 1 on any mismatch.
+
+int nb_failures = 0;
+
+bool sameHit(const RayHit& a, const RayHit& b) {
+    if (a.hit != b.hit) return false;
+    if (!a.hit) return true;
+    if (std::fabs(a.distance - b.distance) > 1e-3f * std::max(1.0f, a.distance)) return false;
+    if (a.instance == b.instance) return glm::length(a.normal - b.normal) < 1e-3f;
+    return true; // two instances at (almost) the same distance
+}
+
+void check(const SphereQuery& query, const std::vector<Ray>& rays, const char* stage) {
+    std::vector<RayHit> batch_hits;
+    query.intersect(rays, batch_hits);
+
+    // packets whose rays point in different directions
+    std::vector<RayHit> packet_hits(rays.size());
+    size_t i = 0;
+    for (; i + 4 <= rays.size(); i += 4) {
+        query.intersectPacket(&rays[i], &packet_hits[i]);
+    }
+    for (; i < rays.size(); ++i) {
+        packet_hits[i] = query.intersect(rays[i]);
+    }
+
+    size_t nb_mismatch = 0;
+    size_t nb_hits = 0;
+    for (size_t k = 0; k < rays.size(); ++k) {
+        RayHit reference = query.intersectBruteForce(rays[k]);
+        nb_hits += reference.hit;
+        if (!sameHit(reference, query.intersect(rays[k]))
+            || !sameHit(reference, batch_hits[k])
+            || !sameHit(reference, packet_hits[k])) {
+            ++nb_mismatch;
+        }
+    }
+    std::cout << stage << ": " << rays.size() << " rays, " << nb_hits << " hits, "
+              << nb_mismatch << " mismatches" << std::endl;
+    if (nb_mismatch > 0 || nb_hits == 0) ++nb_failures;
+}
+
+int main() {
+    const size_t nb_instances = 3000;
+    const float half_size = 20.0f;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-half_size, half_size);
+    std::uniform_real_distribution<float> radius(0.2f, 1.0f);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+
+    std::vector<glm::vec4> spheres(nb_instances);
+    for (auto& s : spheres) {
+        s = glm::vec4(position(rng), position(rng), position(rng), radius(rng));
+    }
+
+    // coherent camera rays followed by random rays from inside the scene,
+    // which also start inside some of the spheres
+    auto camera = Camera(glm::vec3(0.0f, 2.0f, 2.0f * half_size));
+    std::vector<Ray> rays;
+    SphereQuery::generateRays(camera, 64, 64, rays);
+    for (int i = 0; i < 4096; ++i) {
+        glm::vec3 direction = glm::normalize(glm::vec3(normal(rng), normal(rng), normal(rng)));
+        rays.push_back(Ray{ glm::vec3(position(rng), position(rng), position(rng)), direction });
+    }
+    // axis aligned directions, the slab test divides by 0 components
+    rays.push_back(Ray{ glm::vec3(0.0f, 0.0f, 2.0f * half_size), glm::vec3(0.0f, 0.0f, -1.0f) });
+    rays.push_back(Ray{ glm::vec3(2.0f * half_size, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f) });
+    rays.push_back(Ray{ glm::vec3(0.0f, 2.0f * half_size, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f) });
+    rays.push_back(Ray{ glm::vec3(0.0f, -2.0f * half_size, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) });
+
+    SphereQuery query;
+    query.setInstances(spheres);
+    check(query, rays, "build");
+
+    // small moves: the tree is refitted
+    std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+    for (size_t i = 0; i < nb_instances; i += 3) {
+        glm::vec4 s = spheres[i];
+        query.setInstance(i, glm::vec3(s) + glm::vec3(jitter(rng), jitter(rng), jitter(rng)), s.w);
+    }
+    if (query.update()) {
+        std::cout << "refit: unexpected rebuild" << std::endl;
+        ++nb_failures;
+    }
+    check(query, rays, "refit");
+
+    // scatter every instance: the refitted tree is too loose and gets rebuilt
+    for (size_t i = 0; i < nb_instances; ++i) {
+        query.setInstance(i, glm::vec3(position(rng), position(rng), position(rng)), radius(rng));
+    }
+    if (!query.update()) {
+        std::cout << "rebuild: update() did not rebuild" << std::endl;
+        ++nb_failures;
+    }
+    check(query, rays, "rebuild");
+
+    return nb_failures == 0 ? 0 : 1;
+}